@@ -0,0 +1,172 @@
+#include "adaptive.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+YOLO8Adaptive::YOLO8Adaptive()
+    : level(0), overCount(0), underCount(0), lastP95(0.0)
+{}
+
+YOLO8Adaptive::~YOLO8Adaptive()
+{
+    ReleaseSessions();
+}
+
+
+void YOLO8Adaptive::ReleaseSessions()
+{
+    for (YOLO8Onnx* session : sessions)
+    {
+        delete session;
+    }
+    sessions.clear();
+}
+
+
+char* YOLO8Adaptive::CreateSession(DL_ADAPTIVE_PARAM& iParams)
+{
+    if (!sessions.empty())
+    {
+        return "[YOLO_V8]: Adaptive session is already created.";
+    }
+    if (iParams.ladder.empty())
+    {
+        return "[YOLO_V8]: Adaptive ladder is empty.";
+    }
+    if (iParams.windowSize < 1 || iParams.stepDownAfter < 1 || iParams.stepUpAfter < 1)
+    {
+        return "[YOLO_V8]: Adaptive window and hysteresis counts must be positive.";
+    }
+
+    params                  = iParams;
+
+    // Every level is loaded and warmed up front so switching never stalls a frame.
+    for (size_t i = 0; i < params.ladder.size(); i++)
+    {
+        YOLO8Onnx* session  = new YOLO8Onnx();
+        session->classes    = classes;
+        sessions.push_back(session);
+
+        char* ret           = session->CreateSession(params.ladder[i]);
+        if (ret != RET_OK)
+        {
+            ReleaseSessions();
+            return ret;
+        }
+    }
+
+    level                   = std::clamp(params.startLevel, 0, int(sessions.size()) - 1);
+    overCount               = 0;
+    underCount              = 0;
+    lastP95                 = 0.0;
+    latencies.clear();
+
+    return RET_OK;
+}
+
+
+char* YOLO8Adaptive::RunSession(cv::Mat& iImg, std::vector<DL_RESULT>& oResult)
+{
+    if (sessions.empty())
+    {
+        return "[YOLO_V8]: Adaptive session is not created.";
+    }
+
+    int usedLevel           = level;
+    size_t first            = oResult.size();
+
+    auto start              = std::chrono::steady_clock::now();
+    char* ret               = sessions[usedLevel]->RunSession(iImg, oResult);
+    auto end                = std::chrono::steady_clock::now();
+
+    if (ret != RET_OK)
+    {
+        return ret;
+    }
+
+    for (size_t i = first; i < oResult.size(); i++)
+    {
+        oResult[i].level    = usedLevel;
+    }
+
+    UpdateLevel(std::chrono::duration<double, std::milli>(end - start).count());
+
+    return RET_OK;
+}
+
+
+void YOLO8Adaptive::SetClasses(const std::vector<std::string>& iClasses)
+{
+    classes                 = iClasses;
+    for (YOLO8Onnx* session : sessions)
+    {
+        session->classes    = classes;
+    }
+}
+
+
+int YOLO8Adaptive::CurrentLevel() const
+{
+    return level;
+}
+
+
+double YOLO8Adaptive::CurrentP95() const
+{
+    return lastP95;
+}
+
+
+void YOLO8Adaptive::UpdateLevel(double latencyMs)
+{
+    latencies.push_back(latencyMs);
+    if (int(latencies.size()) > params.windowSize)
+    {
+        latencies.pop_front();
+    }
+
+    // Only judge a level once it has a full window of its own samples.
+    if (int(latencies.size()) < params.windowSize)
+    {
+        return;
+    }
+
+    std::vector<double> sorted(latencies.begin(), latencies.end());
+    size_t rank             = size_t(std::ceil(0.95 * sorted.size())) - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    lastP95                 = sorted[rank];
+
+    if (lastP95 > params.p95TargetMs)
+    {
+        underCount          = 0;
+        if (++overCount >= params.stepDownAfter && level + 1 < int(sessions.size()))
+        {
+            SwitchLevel(level + 1);
+        }
+    }
+    else if (lastP95 < params.p95TargetMs * params.stepUpHeadroom)
+    {
+        overCount           = 0;
+        if (++underCount >= params.stepUpAfter && level > 0)
+        {
+            SwitchLevel(level - 1);
+        }
+    }
+    else
+    {
+        overCount           = 0;
+        underCount          = 0;
+    }
+}
+
+
+void YOLO8Adaptive::SwitchLevel(int newLevel)
+{
+    std::cout << "[YOLO_V8]: p95 " << lastP95 << "ms vs target " << params.p95TargetMs
+              << "ms, switching level " << level << " -> " << newLevel << "." << std::endl;
+
+    level                   = newLevel;
+    overCount               = 0;
+    underCount              = 0;
+    latencies.clear();
+}
@@ -0,0 +1,50 @@
+#include "cascade.h"
+
+YOLO8Cascade::YOLO8Cascade(YOLO8Onnx& iDetector, YOLO8Onnx& iClassifier)
+    : detector(&iDetector), classifier(&iClassifier)
+{}
+
+YOLO8Cascade::~YOLO8Cascade()
+{}
+
+
+char* YOLO8Cascade::RunSession(cv::Mat& iImg, std::vector<DL_CASCADE_RESULT>& oResult)
+{
+    std::vector<DL_RESULT> detections;
+    char* ret           = detector->RunSession(iImg, detections);
+    if (ret != RET_OK)
+    {
+        return ret;
+    }
+
+    return Classify(iImg, detections, oResult);
+}
+
+
+char* YOLO8Cascade::Classify(cv::Mat& iImg, const std::vector<DL_RESULT>& iDetections, std::vector<DL_CASCADE_RESULT>& oResult)
+{
+    std::vector<cv::Rect> rois;
+    rois.reserve(iDetections.size());
+    for (const DL_RESULT& detection : iDetections)
+    {
+        rois.push_back(detection.box);
+    }
+
+    std::vector<std::vector<DL_RESULT>> labels;
+    char* ret           = classifier->RunBatchSession(iImg, rois, labels);
+    if (ret != RET_OK)
+    {
+        return ret;
+    }
+
+    oResult.reserve(oResult.size() + iDetections.size());
+    for (size_t i = 0; i < iDetections.size(); i++)
+    {
+        DL_CASCADE_RESULT result;
+        result.detection    = iDetections[i];
+        result.labels       = std::move(labels[i]);
+        oResult.push_back(std::move(result));
+    }
+
+    return RET_OK;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <deque>
+#include "inference.h"
+
+typedef struct _DL_ADAPTIVE_PARAM
+{
+    // Level 0 is the most accurate session, the last one the cheapest
+    // (e.g. 640/480/320 input sizes, or the s/n variants of a model).
+    std::vector<DL_INIT_PARAM> ladder;
+    int startLevel          = 0;
+    double p95TargetMs      = 100.0;
+    int windowSize          = 30;       // latency samples used for the p95 estimate
+    int stepDownAfter       = 3;        // consecutive frames over target before degrading
+    int stepUpAfter         = 30;       // consecutive frames under headroom before upgrading
+    float stepUpHeadroom    = 0.7;      // p95 must be below target * headroom to step up
+} DL_ADAPTIVE_PARAM;
+
+
+class YOLO8Adaptive
+{
+    public:
+        YOLO8Adaptive();
+
+        ~YOLO8Adaptive();
+
+    public:
+        char* CreateSession(DL_ADAPTIVE_PARAM& iParams);
+
+        char* RunSession(cv::Mat& iImg, std::vector<DL_RESULT>& oResult);
+
+        // Class names are forwarded to every ladder session, before or after CreateSession.
+        void SetClasses(const std::vector<std::string>& iClasses);
+
+        int CurrentLevel() const;
+
+        double CurrentP95() const;
+
+    private:
+        void ReleaseSessions();
+
+        void UpdateLevel(double latencyMs);
+
+        void SwitchLevel(int newLevel);
+
+        std::vector<YOLO8Onnx*> sessions;
+        std::vector<std::string> classes;
+
+        int level;
+        int overCount;
+        int underCount;
+        double lastP95;
+
+        std::deque<double> latencies;
+
+        DL_ADAPTIVE_PARAM params;
+};
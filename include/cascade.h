@@ -0,0 +1,29 @@
+#pragma once
+
+#include "inference.h"
+
+typedef struct _DL_CASCADE_RESULT
+{
+    DL_RESULT detection;
+    std::vector<DL_RESULT> labels;  // classifier top-k for the detected box, best first
+} DL_CASCADE_RESULT;
+
+
+// Detector -> classifier pipeline: all crops of a frame are classified in a
+// single batched run of the classifier. Both sessions are owned by the caller.
+class YOLO8Cascade
+{
+    public:
+        YOLO8Cascade(YOLO8Onnx& iDetector, YOLO8Onnx& iClassifier);
+
+        ~YOLO8Cascade();
+
+    public:
+        char* RunSession(cv::Mat& iImg, std::vector<DL_CASCADE_RESULT>& oResult);
+
+        char* Classify(cv::Mat& iImg, const std::vector<DL_RESULT>& iDetections, std::vector<DL_CASCADE_RESULT>& oResult);
+
+    private:
+        YOLO8Onnx* detector;
+        YOLO8Onnx* classifier;
+};
@@ -28,9 +28,25 @@ enum MODEL_TYPE
     // Float16 model
     YOLO_DETECT_V8_HALF = 4,
     YOLO_POSE_V8_HALF   = 5,
-    YOLO_CLS_HALF       = 6
+    YOLO_CLS_HALF       = 6,
+
+    // End-to-end detection models with decode + NMS inside the graph. The last
+    // graph output must be [1, max_det, 6] (x1, y1, x2, y2, score, class) or
+    // [N, 7] with a leading batch index.
+    YOLO_DETECT_E2E         = 7,
+    YOLO_DETECT_E2E_HALF    = 8
 };
 
+inline bool IsHalfModel(MODEL_TYPE modelType)
+{
+    return modelType == YOLO_DETECT_V8_HALF || modelType == YOLO_POSE_V8_HALF
+        || modelType == YOLO_CLS_HALF || modelType == YOLO_DETECT_E2E_HALF;
+}
+
+class YOLO8Runtime;
+class YOLO8Renderer;
+class YOLO8AsyncWriter;
+
 typedef struct _DL_INIT_PARAM
 {
     std::string modelPath;
@@ -39,9 +55,11 @@ typedef struct _DL_INIT_PARAM
     float rectConfidenceThreshold   = 0.6;
     float iouThreshold      = 0.5;
     int keyPointsNum        = 2;
+    int topK                = 5;    // classification scores kept per image, <= 0 keeps all
     bool cudaEnable         = false;
     int logSeverityLevel    = 3;
-    int intraOpNumThreads   = 1;
+    int intraOpNumThreads   = 1;    // ignored when a shared runtime is used
+    YOLO8Runtime* runtime   = nullptr;
 } DL_INIT_PARAM;
 
 
@@ -51,6 +69,7 @@ typedef struct _DL_RESULT
     float confidence;
     cv::Rect box;
     std::vector<cv::Point2f> keyPoints;
+    int level               = 0;    // ladder level that produced this result (YOLO8Adaptive)
 } DL_RESULT;
 
 
@@ -66,19 +85,30 @@ class YOLO8Onnx
 
         char* RunSession(cv::Mat& iImg, std::vector<DL_RESULT>& oResult);
 
+        // Classify every ROI of iImg in one batched run (YOLO_CLS models only).
+        // oResults[i] holds the top-k classes for iRois[i]. A single run needs a
+        // dynamic-batch export; a fixed batch of N runs once per N crops.
+        char* RunBatchSession(cv::Mat& iImg, const std::vector<cv::Rect>& iRois, std::vector<std::vector<DL_RESULT>>& oResults);
+
         char* WarmUpSession();
 
         template<typename N>
         char* TensorProcess(clock_t& starttime_1, cv::Mat& iImg, N& blob, std::vector<int64_t>& inputNodeDims, std::vector<DL_RESULT>& oResult);
 
+        template<typename N>
+        char* BatchProcess(cv::Mat& iImg, const std::vector<cv::Rect>& iRois, std::vector<std::vector<DL_RESULT>>& oResults);
+
         char* PreProcess(cv::Mat& iImg, std::vector<int> iImgSize, cv::Mat& oImg);
 
-        char* ProcessInput(const std::string& input, std::vector<DL_RESULT>& results);
+        // Runs every frame of an image or video; when given, frames are annotated by
+        // renderer and handed to writer. GUI display is controlled by the renderer.
+        char* ProcessInput(const std::string& input, std::vector<DL_RESULT>& results,
+                           YOLO8Renderer* renderer = nullptr, YOLO8AsyncWriter* writer = nullptr);
 
         std::vector<std::string> classes{};
 
     private:
-        Ort::Env env;
+        Ort::Env env{ nullptr };
         Ort::Session* session;
 
         bool cudaEnable;
@@ -91,6 +121,8 @@ class YOLO8Onnx
         MODEL_TYPE modelType;
 
         std::vector<int> imgSize;
+        int64_t inputBatch;
+        int topK;
 
         float rectConfidenceThreshold;
         float iouThreshold;
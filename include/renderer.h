@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "inference.h"
+
+typedef struct _DL_RENDER_PARAM
+{
+    int thickness           = 2;
+    double fontScale        = 0.5;
+    bool showWindow         = false;    // imshow every rendered frame
+    bool verbose            = false;    // log every drawn detection
+    int jpegQuality         = 90;
+    double videoFps         = 30.0;     // used when the source reports no frame rate
+    std::string videoFourcc = "mp4v";
+    size_t maxQueue         = 8;        // frames waiting for the encoder before Submit blocks
+} DL_RENDER_PARAM;
+
+
+// Draws detections straight onto the frame with a per-class palette computed
+// once and label text sizes cached per (class, confidence percent).
+class YOLO8Renderer
+{
+    public:
+        YOLO8Renderer();
+
+        ~YOLO8Renderer();
+
+    public:
+        char* CreateRenderer(const std::vector<std::string>& iClasses, DL_RENDER_PARAM& iParams);
+
+        char* Render(cv::Mat& ioImg, const std::vector<DL_RESULT>& iResults);
+
+        const DL_RENDER_PARAM& Params() const;
+
+    private:
+        cv::Size LabelSize(int classId, int percent, const std::string& label);
+
+        std::vector<std::string> classes;
+        std::vector<cv::Scalar> palette;
+        std::vector<cv::Size> labelSizes;   // classes x 101 confidence steps, measured lazily
+
+        DL_RENDER_PARAM params;
+};
+
+
+// Encodes frames on a background thread: images go through imwrite with the
+// configured JPEG quality, any other extension through cv::VideoWriter.
+class YOLO8AsyncWriter
+{
+    public:
+        YOLO8AsyncWriter();
+
+        ~YOLO8AsyncWriter();
+
+    public:
+        char* Open(const std::string& outputPath, DL_RENDER_PARAM& iParams);
+
+        // The frame is copied, so the caller may reuse its buffer immediately.
+        // sourceFps sets the video rate when the writer opens; 0 falls back to videoFps.
+        char* Submit(const cv::Mat& iImg, double sourceFps = 0.0);
+
+        // Drains the queue and stops the encoder thread.
+        char* Close();
+
+    private:
+        void WriterLoop();
+
+        char* Encode(const cv::Mat& iImg, double fps);
+
+        std::thread worker;
+        std::mutex queueMutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        std::deque<cv::Mat> queue;
+        bool closing;
+        double sourceFps;
+        std::atomic<char*> error;
+
+        bool isVideo;
+        std::string path;
+        cv::VideoWriter video;
+        std::vector<int> encodeParams;
+        int frameIndex;
+
+        DL_RENDER_PARAM params;
+};
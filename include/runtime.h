@@ -0,0 +1,52 @@
+#pragma once
+
+#include "inference.h"
+
+typedef struct _DL_RUNTIME_PARAM
+{
+    int intraOpNumThreads   = 0;        // 0 lets ORT pick one thread per physical core
+    int interOpNumThreads   = 1;
+    // ORT affinity string for the global intra-op pool, e.g. "1;2;3" (one entry per
+    // thread except the caller). Empty keeps the OS scheduling.
+    std::string intraOpThreadAffinity;
+    bool allowSpinning      = true;
+    bool sharedCpuArena     = true;
+    int logSeverityLevel    = 3;
+} DL_RUNTIME_PARAM;
+
+
+typedef struct _DL_RUNTIME_STATS
+{
+    long residentKb         = 0;        // current resident set size
+    long peakResidentKb     = 0;
+    long voluntaryCtxSwitches   = 0;
+    long involuntaryCtxSwitches = 0;
+} DL_RUNTIME_STATS;
+
+
+// Process-wide ONNX Runtime state shared by every YOLO8Onnx that points
+// DL_INIT_PARAM::runtime at it. ORT keeps a single OrtEnv per process, so the
+// runtime must be created before any YOLO8Onnx session.
+class YOLO8Runtime
+{
+    public:
+        YOLO8Runtime();
+
+        ~YOLO8Runtime();
+
+    public:
+        char* CreateRuntime(DL_RUNTIME_PARAM& iParams);
+
+        void ApplySessionOptions(Ort::SessionOptions& sessionOptions) const;
+
+        Ort::Env& GetEnv();
+
+        static char* QueryStats(DL_RUNTIME_STATS& oStats);
+
+        static void PrintStats(const char* tag, const DL_RUNTIME_STATS& iStats);
+
+    private:
+        Ort::Env env{ nullptr };
+
+        bool sharedCpuArena;
+};
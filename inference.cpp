@@ -1,13 +1,18 @@
 #include "inference.h"
+#include "runtime.h"
+#include "renderer.h"
 #include <filesystem>
 #include <thread>
 #include <chrono>
 #include <regex>
+#include <algorithm>
+#include <numeric>
 
 #define benchmark
 #define min(a, b) (((a) < (b)) ? (a) : (b))
 
 YOLO8Onnx::YOLO8Onnx()
+    : session(nullptr), cudaEnable(false), inputBatch(1), topK(5)
 {}
 
 YOLO8Onnx::~YOLO8Onnx()
@@ -44,6 +49,52 @@ char* BlobFromImage(cv::Mat& iImg, T& iBlob)
     return RET_OK;
 }
 
+// Resize a BGR crop into the blob slot and swap to RGB planes in the same pass,
+// so batched crops skip the clone/cvtColor of PreProcess.
+template<typename T>
+char* BlobFromCrop(cv::Mat& iCrop, T* oBlob)
+{
+    int imgHeight   = iCrop.rows;
+    int imgWidth    = iCrop.cols;
+    int planeSize   = imgHeight * imgWidth;
+
+    for (int h = 0; h < imgHeight; h++)
+    {
+        const uchar* row = iCrop.ptr<uchar>(h);
+        for (int w = 0; w < imgWidth; w++)
+        {
+            int idx             = h * imgWidth + w;
+            oBlob[idx]                  = T(row[3 * w + 2] / 255.0f);
+            oBlob[planeSize + idx]      = T(row[3 * w + 1] / 255.0f);
+            oBlob[2 * planeSize + idx]  = T(row[3 * w] / 255.0f);
+        }
+    }
+
+    return RET_OK;
+}
+
+// Push the k best scores in descending order; only k elements get sorted.
+void TopKScores(const float* scores, int numScores, int k, std::vector<DL_RESULT>& oResult)
+{
+    if (k <= 0 || k > numScores)
+    {
+        k = numScores;
+    }
+
+    std::vector<int> indices(numScores);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::partial_sort(indices.begin(), indices.begin() + k, indices.end(),
+        [scores](int a, int b) { return scores[a] > scores[b]; });
+
+    for (int i = 0; i < k; i++)
+    {
+        DL_RESULT result;
+        result.classId      = indices[i];
+        result.confidence   = scores[indices[i]];
+        oResult.push_back(result);
+    }
+}
+
 char* YOLO8Onnx::PreProcess(cv::Mat& iImg, std::vector<int> iImgSize, cv::Mat& oImg)
 {
     if (iImg.channels() == 3)
@@ -62,6 +113,8 @@ char* YOLO8Onnx::PreProcess(cv::Mat& iImg, std::vector<int> iImgSize, cv::Mat& o
         case YOLO_POSE:
         case YOLO_DETECT_V8_HALF:
         case YOLO_POSE_V8_HALF:
+        case YOLO_DETECT_E2E:
+        case YOLO_DETECT_E2E_HALF:
         {
             if (iImg.cols >= iImg.rows)
             {
@@ -80,6 +133,7 @@ char* YOLO8Onnx::PreProcess(cv::Mat& iImg, std::vector<int> iImgSize, cv::Mat& o
             break;
         }
         case YOLO_CLS:
+        case YOLO_CLS_HALF:
         {
             int h               = iImg.rows;
             int w               = iImg.cols;
@@ -114,9 +168,13 @@ char* YOLO8Onnx::CreateSession(DL_INIT_PARAM& iParams)
         iouThreshold                = iParams.iouThreshold;
         imgSize                     = iParams.imgSize;
         modelType                   = iParams.modelType;
+        topK                        = iParams.topK;
 
-        env                         = Ort::Env(ORT_LOGGING_LEVEL_WARNING, "Yolo");
         Ort::SessionOptions sessionOptions;
+        if (iParams.runtime == nullptr)
+        {
+            env                     = Ort::Env(ORT_LOGGING_LEVEL_WARNING, "Yolo");
+        }
         if (iParams.cudaEnable)
         {
             cudaEnable              = iParams.cudaEnable;
@@ -126,7 +184,14 @@ char* YOLO8Onnx::CreateSession(DL_INIT_PARAM& iParams)
         }
 
         sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-        sessionOptions.SetIntraOpNumThreads(iParams.intraOpNumThreads);
+        if (iParams.runtime != nullptr)
+        {
+            iParams.runtime->ApplySessionOptions(sessionOptions);
+        }
+        else
+        {
+            sessionOptions.SetIntraOpNumThreads(iParams.intraOpNumThreads);
+        }
         sessionOptions.SetLogSeverityLevel(iParams.logSeverityLevel);
 
 #if _WIN32
@@ -140,13 +205,14 @@ char* YOLO8Onnx::CreateSession(DL_INIT_PARAM& iParams)
         const char* modelPath       = iParams.modelPath.c_str();
 #endif
 
-        session                     = new Ort::Session(env, modelPath, sessionOptions);
+        Ort::Env& sessionEnv        = (iParams.runtime != nullptr) ? iParams.runtime->GetEnv() : env;
+        session                     = new Ort::Session(sessionEnv, modelPath, sessionOptions);
         Ort::AllocatorWithDefaultOptions allocator;
         size_t inputNodesNum        = session ->GetInputCount();
         for (size_t i = 0; i < inputNodesNum; i++)
         {
             Ort::AllocatedStringPtr input_node_name = session->GetInputNameAllocated(i, allocator);
-            char* temp_buf          = new char[50];
+            char* temp_buf          = new char[strlen(input_node_name.get()) + 1];
             strcpy(temp_buf, input_node_name.get());
             inputNodeNames.push_back(temp_buf);
         }
@@ -155,11 +221,29 @@ char* YOLO8Onnx::CreateSession(DL_INIT_PARAM& iParams)
         for (size_t i = 0; i < OutputNodesNum; i++)
         {
             Ort::AllocatedStringPtr output_node_name = session->GetOutputNameAllocated(i, allocator);
-            char* temp_buf          = new char[10];
+            char* temp_buf          = new char[strlen(output_node_name.get()) + 1];
             strcpy(temp_buf, output_node_name.get());
             outputNodeNames.push_back(temp_buf);
         }
 
+        // End-to-end graphs may still expose the raw head; only fetch the compact detections.
+        if ((modelType == YOLO_DETECT_E2E || modelType == YOLO_DETECT_E2E_HALF) && outputNodeNames.size() > 1)
+        {
+            for (size_t i = 0; i + 1 < outputNodeNames.size(); i++)
+            {
+                delete[] outputNodeNames[i];
+            }
+            outputNodeNames.erase(outputNodeNames.begin(), outputNodeNames.end() - 1);
+        }
+
+        std::vector<int64_t> inputShape = session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        inputBatch                  = inputShape.empty() ? 1 : inputShape[0];
+        if ((modelType == YOLO_CLS || modelType == YOLO_CLS_HALF) && inputBatch == 1)
+        {
+            std::cout << "[YOLO_V8]: Classifier has a fixed batch of 1, RunBatchSession will run once per crop. "
+                      << "Export with a dynamic batch axis to classify all crops in one run." << std::endl;
+        }
+
         options                     = Ort::RunOptions{ nullptr };
 
         WarmUpSession();
@@ -193,19 +277,19 @@ char* YOLO8Onnx::RunSession(cv::Mat& iImg, std::vector<DL_RESULT>& oResult) {
         cv::Mat processedImg;
 
         PreProcess(iImg, imgSize, processedImg);
-        if (modelType < 4)
+        if (!IsHalfModel(modelType))
         {
             float* blob     = new float[processedImg.total() * 3];
             BlobFromImage(processedImg, blob);
             std::vector<int64_t> inputNodeDims  = { 1, 3, imgSize.at(0), imgSize.at(1) };
-            TensorProcess(starttime_1, iImg, blob, inputNodeDims, oResult);
+            Ret             = TensorProcess(starttime_1, iImg, blob, inputNodeDims, oResult);
         }
         else{
 #ifdef USE_CUDA
             half* blob      = new half[processedImg.total() * 3];
             BlobFromImage(processedImg, blob);
             std::vector<int64_t> inputNodeDims  = { 1, 3, imgSize.at(0), imgSize.at(1) };
-            TensorProcess(starttime_1, iImg, blob, inputNodeDims, oResult);
+            Ret             = TensorProcess(starttime_1, iImg, blob, inputNodeDims, oResult);
 #endif
         }
 
@@ -213,12 +297,29 @@ char* YOLO8Onnx::RunSession(cv::Mat& iImg, std::vector<DL_RESULT>& oResult) {
 }
 
 
+#ifdef benchmark
+void PrintBenchmark(bool cudaEnable, clock_t starttime_1, clock_t starttime_2, clock_t starttime_3, clock_t starttime_4)
+{
+    double pre_process_time =   (double)(starttime_2 - starttime_1) / CLOCKS_PER_SEC * 1000;
+    double process_time = (double)(starttime_3 - starttime_2) / CLOCKS_PER_SEC * 1000;
+    double post_process_time    = (double)(starttime_4 - starttime_3) / CLOCKS_PER_SEC * 1000;
+
+    if (cudaEnable)
+    {
+        std::cout << "[YOLO_V8(CUDA)]: " << pre_process_time << "ms pre-process, " << process_time << "ms inference, " << post_process_time << "ms post-process." << std::endl;
+    }
+    else {
+        std::cout << "[YOLO_V8(CPU)]: " << pre_process_time << "ms pre-process, " << process_time << "ms inference, " << post_process_time << "ms post-process." << std::endl;
+    }
+}
+#endif
+
+
 template<typename N>
 char* YOLO8Onnx::TensorProcess(clock_t& starttime_1, cv::Mat& iImg, N& blob, std::vector<int64_t>& inputNodeDims, std::vector<DL_RESULT>& oResult)
 {
     std::vector<float> confidences;
     std::vector<int> class_ids;
-    int top = 0;
 
     Ort::Value inputTensor  = Ort::Value::CreateTensor<typename std::remove_pointer<N>::type>(
         Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU), blob, 3 * imgSize.at(0) * imgSize.at(1),
@@ -281,7 +382,7 @@ char* YOLO8Onnx::TensorProcess(clock_t& starttime_1, cv::Mat& iImg, N& blob, std
                 
                 if (maxClassScore > rectConfidenceThreshold)
                 {
-                    confidences.push_back(class_id.x);
+                    confidences.push_back(float(maxClassScore));
                     class_ids.push_back(class_id.x);
 
                     float   x   = data[0];
@@ -290,7 +391,7 @@ char* YOLO8Onnx::TensorProcess(clock_t& starttime_1, cv::Mat& iImg, N& blob, std
                     float   h   = data[3];
 
                     int     left= int((x - 0.5 * w) * resizeScales);
-                    int     right= int((y - 0.5 * h) * resizeScales);
+                    int     top = int((y - 0.5 * h) * resizeScales);
 
                     int width   = int(w * resizeScales);
                     int height  = int(h * resizeScales);
@@ -317,19 +418,52 @@ char* YOLO8Onnx::TensorProcess(clock_t& starttime_1, cv::Mat& iImg, N& blob, std
 
 
 #ifdef benchmark
-            clock_t starttime_4 = clock();
-            double pre_process_time =   (double)(starttime_2 - starttime_1) / CLOCKS_PER_SEC * 1000;
-            double process_time = (double)(starttime_3 - starttime_2) / CLOCKS_PER_SEC * 1000;
-            double post_process_time    = (double)(starttime_4 - starttime_3) / CLOCKS_PER_SEC * 1000;
+            PrintBenchmark(cudaEnable, starttime_1, starttime_2, starttime_3, clock());
+#endif
+            break;
+        }
 
-            if (cudaEnable)
+        case YOLO_DETECT_E2E:
+        case YOLO_DETECT_E2E_HALF:
+        {
+            // Rows are already decoded and suppressed in the graph; read them in place.
+            int rowNum          = outputNodeDims.size() >= 2 ? int(outputNodeDims[outputNodeDims.size() - 2]) : 0;
+            int rowSize         = int(outputNodeDims.back());
+            int offset          = (rowSize == 7) ? 1 : 0;
+
+            if (rowSize != 6 && rowSize != 7)
             {
-                std::cout << "[YOLO_V8(CUDA)]: " << pre_process_time << "ms pre-process, " << process_time << "ms inference, " << post_process_time << "ms post-process." << std::endl;
+                return "[YOLO_V8]: End-to-end output must have 6 or 7 values per detection.";
             }
-            else {
-                std::cout << "[YOLO_V8(CPU)]: " << pre_process_time << "ms pre-process, " << process_time << "ms inference, " << post_process_time << "ms post-process." << std::endl;
+
+            cv::Mat rawData;
+            if (modelType == YOLO_DETECT_E2E)
+            {
+                rawData         = cv::Mat(rowNum, rowSize, CV_32F, output);
+            }
+            else
+            {
+                cv::Mat(rowNum, rowSize, CV_16F, output).convertTo(rawData, CV_32F);
             }
 
+            for (int i = 0; i < rowNum; i++)
+            {
+                const float* row    = rawData.ptr<float>(i) + offset;
+                if (row[4] <= rectConfidenceThreshold)
+                {
+                    continue;
+                }
+
+                DL_RESULT   result;
+                result.classId  = int(row[5]);
+                result.confidence   = row[4];
+                result.box      = cv::Rect(int(row[0] * resizeScales), int(row[1] * resizeScales),
+                                           int((row[2] - row[0]) * resizeScales), int((row[3] - row[1]) * resizeScales));
+                oResult.push_back(result);
+            }
+
+#ifdef benchmark
+            PrintBenchmark(cudaEnable, starttime_1, starttime_2, starttime_3, clock());
 #endif
             break;
         }
@@ -337,25 +471,18 @@ char* YOLO8Onnx::TensorProcess(clock_t& starttime_1, cv::Mat& iImg, N& blob, std
         case YOLO_CLS:
         case YOLO_CLS_HALF:
         {
+            int numClasses  = int(outputNodeDims.back());
             cv::Mat rawData;
             if (modelType == YOLO_CLS)
             {
-                rawData = cv::Mat(1, this->classes.size(), CV_32F, output); 
+                rawData = cv::Mat(1, numClasses, CV_32F, output);
             }
             else 
             {
-                rawData = cv::Mat(1, this->classes.size(), CV_16F, output); 
+                cv::Mat(1, numClasses, CV_16F, output).convertTo(rawData, CV_32F);
             }
 
-            float *data = (float *) rawData.data;
-
-            DL_RESULT result;
-            for (int i = 0; i < this->classes.size(); i++)  
-            {
-                result.classId = i;
-                result.confidence = data[i];
-                oResult.push_back(result);
-            }
+            TopKScores((float*)rawData.data, numClasses, topK, oResult);
 
             break;
         }
@@ -368,13 +495,108 @@ char* YOLO8Onnx::TensorProcess(clock_t& starttime_1, cv::Mat& iImg, N& blob, std
 }
 
 
+char* YOLO8Onnx::RunBatchSession(cv::Mat& iImg, const std::vector<cv::Rect>& iRois, std::vector<std::vector<DL_RESULT>>& oResults)
+{
+    if (modelType != YOLO_CLS && modelType != YOLO_CLS_HALF)
+    {
+        return "[YOLO_V8]: Batch session only supports classification models.";
+    }
+
+    oResults.assign(iRois.size(), std::vector<DL_RESULT>());
+    if (iRois.empty())
+    {
+        return RET_OK;
+    }
+
+    cv::Mat bgrImg  = iImg;
+    if (iImg.channels() == 1)
+    {
+        cv::cvtColor(iImg, bgrImg, cv::COLOR_GRAY2BGR);
+    }
+
+    if (!IsHalfModel(modelType))
+    {
+        return BatchProcess<float>(bgrImg, iRois, oResults);
+    }
+#ifdef USE_CUDA
+    return BatchProcess<half>(bgrImg, iRois, oResults);
+#else
+    return "[YOLO_V8]: Half precision models need USE_CUDA.";
+#endif
+}
+
+
+template<typename N>
+char* YOLO8Onnx::BatchProcess(cv::Mat& iImg, const std::vector<cv::Rect>& iRois, std::vector<std::vector<DL_RESULT>>& oResults)
+{
+    // A fixed batch dimension is filled chunk by chunk, a dynamic one takes every crop at once.
+    int64_t batch       = inputBatch > 0 ? inputBatch : int64_t(iRois.size());
+    size_t planeSize    = size_t(3) * imgSize.at(0) * imgSize.at(1);
+    std::vector<N> blob(batch * planeSize);
+    std::vector<int64_t> inputNodeDims  = { batch, 3, imgSize.at(0), imgSize.at(1) };
+    cv::Rect frame(0, 0, iImg.cols, iImg.rows);
+    cv::Mat crop;
+
+    for (size_t first = 0; first < iRois.size(); first += batch)
+    {
+        size_t count    = min(size_t(batch), iRois.size() - first);
+        std::fill(blob.begin(), blob.end(), N(0.0f));
+
+        for (size_t i = 0; i < count; i++)
+        {
+            cv::Rect roi    = iRois[first + i] & frame;
+            if (roi.empty())
+            {
+                continue;
+            }
+            // Center-crop inside the box as PreProcess does for a whole image.
+            int m           = min(roi.width, roi.height);
+            cv::Rect square(roi.x + (roi.width - m) / 2, roi.y + (roi.height - m) / 2, m, m);
+            cv::resize(iImg(square), crop, cv::Size(imgSize.at(0), imgSize.at(1)));
+            BlobFromCrop(crop, blob.data() + i * planeSize);
+        }
+
+        Ort::Value inputTensor  = Ort::Value::CreateTensor<N>(
+            Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU), blob.data(), blob.size(),
+            inputNodeDims.data(), inputNodeDims.size());
+
+        auto outputTensor       = session->Run(options, inputNodeNames.data(), &inputTensor, 1, outputNodeNames.data(), outputNodeNames.size());
+
+        std::vector<int64_t> outputNodeDims = outputTensor.front().GetTensorTypeAndShapeInfo().GetShape();
+        int numClasses          = int(outputNodeDims.back());
+        auto output             = outputTensor.front().GetTensorMutableData<N>();
+
+        cv::Mat rawData;
+        if (modelType == YOLO_CLS)
+        {
+            rawData = cv::Mat(int(count), numClasses, CV_32F, output);
+        }
+        else
+        {
+            cv::Mat(int(count), numClasses, CV_16F, output).convertTo(rawData, CV_32F);
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if ((iRois[first + i] & frame).empty())
+            {
+                continue;
+            }
+            TopKScores(rawData.ptr<float>(int(i)), numClasses, topK, oResults[first + i]);
+        }
+    }
+
+    return RET_OK;
+}
+
+
 char* YOLO8Onnx::WarmUpSession() {
     clock_t starttime_1 = clock();
     cv::Mat iImg        = cv::Mat(cv::Size(imgSize.at(0), imgSize.at(1)), CV_8UC3);
     cv::Mat processedImg;
     PreProcess(iImg, imgSize, processedImg);
 
-    if (modelType < 4)
+    if (!IsHalfModel(modelType))
     {
         float* blob = new float[iImg.total() * 3];
         BlobFromImage(processedImg, blob);
@@ -413,11 +635,12 @@ char* YOLO8Onnx::WarmUpSession() {
 }
 
 
-char* YOLO8Onnx::ProcessInput(const std::string& input, std::vector<DL_RESULT>& results) {
+char* YOLO8Onnx::ProcessInput(const std::string& input, std::vector<DL_RESULT>& results, YOLO8Renderer* renderer, YOLO8AsyncWriter* writer) {
     cv::VideoCapture cap;
     cv::Mat frame;
 
     bool isImage = false;
+    bool showWindow = renderer != nullptr && renderer->Params().showWindow;
 
     // Check if input  is an image file
     std::vector<std::string> imageExtensions    = {".jpg", ".jpeg", ".png", ".bmp", ".tiff"};
@@ -431,6 +654,13 @@ char* YOLO8Onnx::ProcessInput(const std::string& input, std::vector<DL_RESULT>&
             return "Error: Unable to open video file or stream";
         }
     }
+    else if (!cap.open(input))
+    {
+        return "Error: Unable to open video file or stream";
+    }
+
+    // Annotated clips keep the source timing; images and unknown rates report 0.
+    double sourceFps = isImage ? 0.0 : cap.get(cv::CAP_PROP_FPS);
 
     // Process frames
     while (true)
@@ -451,24 +681,42 @@ char* YOLO8Onnx::ProcessInput(const std::string& input, std::vector<DL_RESULT>&
             return ret;
         }
 
+        if (renderer != nullptr)
+        {
+            ret         = renderer->Render(frame, frameResults);
+            if (ret != RET_OK)
+            {
+                return ret;
+            }
+        }
+
+        // Encoding runs on the writer thread, the next frame is decoded meanwhile.
+        if (writer != nullptr)
+        {
+            ret         = writer->Submit(frame, sourceFps);
+            if (ret != RET_OK)
+            {
+                return ret;
+            }
+        }
 
         // save up result
         results.insert(results.end(), frameResults.begin(), frameResults.end());
 
-        if (isImage)
+        if (showWindow)
         {
-            break;
-        }
+            cv::imshow("YOLO8 Detection", frame);
 
-        cv::imshow("YOLO8 Detection", frame);
+            if (cv::waitKey(isImage ? 0 : 1) == 27) // Esc ASAP
+            {
+                break;
+            }
+        }
 
-        if (cv::waitKey(1) == 27) // Esc ASAP
+        if (isImage)
         {
             break;
         }
-
-        // track delauy
-        std::this_thread::sleep_for(std::chrono::milliseconds(30));
     }
 
     if (!isImage)
@@ -476,7 +724,10 @@ char* YOLO8Onnx::ProcessInput(const std::string& input, std::vector<DL_RESULT>&
         cap.release();
     }
 
-    cv::destroyAllWindows();
+    if (showWindow)
+    {
+        cv::destroyAllWindows();
+    }
 
     return RET_OK;
-}
\ No newline at end of file
+}
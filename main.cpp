@@ -3,7 +3,10 @@
 #include <filesystem>
 #include <fstream>
 #include <random>
+#include <stdexcept>
 #include "inference.h"
+#include "runtime.h"
+#include "renderer.h"
 
 // read yaml
 std::vector<std::string> ReadClassNames(const std::string& yamlPath) {
@@ -35,73 +38,9 @@ std::vector<std::string> ReadClassNames(const std::string& yamlPath) {
     return names;
 }
 
-void VisualizeAndSaveDetection(cv::Mat& img, const std::vector<DL_RESULT>& results, 
-                              const std::vector<std::string>& classes, 
-                              const std::string& outputPath) {
-    // Debug information
-    std::cout << "Number of detections: " << results.size() << std::endl;
-    
-    for (const auto& result: results) {
-        // Debug print each detection
-        std::cout << "Class: " << classes[result.classId] 
-                  << ", Confidence: " << result.confidence 
-                  << ", Box: [" << result.box.x << ", " << result.box.y 
-                  << ", " << result.box.width << ", " << result.box.height << "]" << std::endl;
-
-        cv::RNG rng(cv::getTickCount());
-        cv::Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
-
-        // Draw the rectangle
-        cv::rectangle(img, result.box, color, 2);
-
-        // Prepare label
-        std::string label = classes[result.classId] + " " + 
-                           std::to_string(static_cast<int>(result.confidence * 100)) + "%";
-
-        // Get label size for background rectangle
-        int baseline = 0;
-        cv::Size labelSize = cv::getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseline);
-
-        // Draw label background
-        cv::rectangle(img, 
-                     cv::Point(result.box.x, result.box.y - labelSize.height - 5),
-                     cv::Point(result.box.x + labelSize.width, result.box.y),
-                     color, cv::FILLED);
-
-        // Draw label text
-        cv::putText(img, label, 
-                    cv::Point(result.box.x, result.box.y - 5),
-                    cv::FONT_HERSHEY_SIMPLEX, 
-                    0.5, cv::Scalar(0, 0, 0), 1);
-
-        // Debug - verify drawing
-        std::cout << "Drew bounding box and label for " << label << std::endl;
-    }
-
-    // Create output directory if it doesn't exist
-    std::filesystem::path outputDir = std::filesystem::path(outputPath).parent_path();
-    if (!std::filesystem::exists(outputDir)) {
-        std::filesystem::create_directories(outputDir);
-        std::cout << "Created output directory: " << outputDir << std::endl;
-    }
-
-    // Save the image with debug information
-    bool saveResult = cv::imwrite(outputPath, img);
-    if (saveResult) {
-        std::cout << "Successfully saved result to: " << outputPath << std::endl;
-    } else {
-        std::cerr << "Failed to save result to: " << outputPath << std::endl;
-    }
-
-    // Display the image
-    cv::imshow("YOLO8 Result", img);
-    cv::waitKey(0);
-    cv::destroyAllWindows();
-}
-
 void VisualizeAndSaveClassification(cv::Mat& img, const std::vector<DL_RESULT>& results, 
                                   const std::vector<std::string>& classes,
-                                  const std::string& outputPath) {
+                                  const std::string& outputPath, bool showWindow) {
     int positionY = 30;
     for (size_t i = 0; i < std::min(results.size(), size_t(5)); i++) {
         cv::RNG rng(cv::getTickCount() + i);
@@ -123,21 +62,69 @@ void VisualizeAndSaveClassification(cv::Mat& img, const std::vector<DL_RESULT>&
     cv::imwrite(outputPath, img);
     std::cout << "Saved result to: " << outputPath << std::endl;
 
-    cv::imshow("YOLO8 Result", img);
-    cv::waitKey(0);
-    cv::destroyAllWindows();
+    if (showWindow) {
+        cv::imshow("YOLO8 Result", img);
+        cv::waitKey(0);
+        cv::destroyAllWindows();
+    }
+}
+
+void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <detect/classify> <model_path> <input_path> [yaml_path]"
+              << " [--show] [--verbose] [--quality=<0-100>] [--threads=<n>] [--affinity=<list>]" << std::endl;
+}
+
+// Parse the whole of value as an integer; throws std::invalid_argument otherwise.
+int ParseIntFlag(const std::string& value) {
+    size_t used = 0;
+    int result = std::stoi(value, &used);
+    if (used != value.size()) {
+        throw std::invalid_argument(value);
+    }
+    return result;
 }
 
 int main(int argc, char* argv[]) {
     if (argc < 4) {
-        std::cerr << "Usage: " << argv[0] << " <detect/classify> <model_path> <input_path> [yaml_path]" << std::endl;
+        PrintUsage(argv[0]);
         return 1;
     }
 
     std::string task = argv[1];
     std::string modelPath = argv[2];
     std::string inputPath = argv[3];
-    std::string yamlPath = (argc > 4) ? argv[4] : "coco.yaml";
+    std::string yamlPath = "coco.yaml";
+
+    DL_RENDER_PARAM renderParams;
+    // One intra-op thread unless asked otherwise, as before the shared runtime.
+    DL_RUNTIME_PARAM runtimeParams;
+    runtimeParams.intraOpNumThreads = 1;
+    for (int i = 4; i < argc; i++) {
+        std::string arg = argv[i];
+        try {
+            if (arg == "--show") {
+                renderParams.showWindow = true;
+            } else if (arg == "--verbose") {
+                renderParams.verbose = true;
+            } else if (arg.rfind("--quality=", 0) == 0) {
+                renderParams.jpegQuality = ParseIntFlag(arg.substr(10));
+            } else if (arg.rfind("--threads=", 0) == 0) {
+                runtimeParams.intraOpNumThreads = ParseIntFlag(arg.substr(10));
+            } else if (arg.rfind("--affinity=", 0) == 0) {
+                runtimeParams.intraOpThreadAffinity = arg.substr(11);
+            } else if (arg.rfind("--", 0) == 0) {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                PrintUsage(argv[0]);
+                return 1;
+            } else {
+                yamlPath = arg;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value in option: " << arg << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
 
     std::filesystem::path inputFilePath(inputPath);
     std::filesystem::path outputDir("/app/output"); 
@@ -147,9 +134,22 @@ int main(int argc, char* argv[]) {
     outputPath = outputPath.substr(0, outputPath.length() - extension.length()) + 
                 "_result" + extension;
 
+    DL_RUNTIME_STATS statsBefore;
+    YOLO8Runtime::QueryStats(statsBefore);
+    YOLO8Runtime::PrintStats("Before session", statsBefore);
+
+    // The runtime must outlive every session created against it.
+    YOLO8Runtime runtime;
+    char* ret = runtime.CreateRuntime(runtimeParams);
+    if (ret != RET_OK) {
+        std::cerr << "Failed to create runtime: " << ret << std::endl;
+        return 1;
+    }
+
     YOLO8Onnx yolo;
     DL_INIT_PARAM params;
     params.modelPath = modelPath;
+    params.runtime = &runtime;
     params.imgSize = (task == "detect") ? std::vector<int>{640, 640} : std::vector<int>{224, 224};
     params.rectConfidenceThreshold = 0.25;
     params.iouThreshold = 0.45;
@@ -161,7 +161,7 @@ int main(int argc, char* argv[]) {
     params.cudaEnable = false;
 #endif
 
-    char* ret = yolo.CreateSession(params);
+    ret = yolo.CreateSession(params);
     if (ret != RET_OK) {
         std::cerr << "Failed to create session: " << ret << std::endl;
         return 1;
@@ -173,20 +173,47 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    yolo.classes = classes;
+
+    // Detection frames are annotated and encoded while the next frame is inferred.
+    YOLO8Renderer renderer;
+    YOLO8AsyncWriter writer;
+    if (task == "detect") {
+        renderer.CreateRenderer(classes, renderParams);
+        ret = writer.Open(outputPath, renderParams);
+        if (ret != RET_OK) {
+            std::cerr << "Failed to open output: " << ret << std::endl;
+            return 1;
+        }
+    }
+
     std::vector<DL_RESULT> results;
-    ret = yolo.ProcessInput(inputPath, results);
+    if (task == "detect") {
+        ret = yolo.ProcessInput(inputPath, results, &renderer, &writer);
+    } else {
+        ret = yolo.ProcessInput(inputPath, results);
+    }
 
     if (ret != RET_OK) {
         std::cerr << "Failed to process input: " << ret << std::endl;
         return 1;
     }
 
-    cv::Mat img = cv::imread(inputPath);
-    
+    DL_RUNTIME_STATS statsAfter;
+    YOLO8Runtime::QueryStats(statsAfter);
+    YOLO8Runtime::PrintStats("After inference", statsAfter);
+
     if (task == "detect") {
-        VisualizeAndSaveDetection(img, results, classes, outputPath);
+        ret = writer.Close();
+        if (ret != RET_OK) {
+            std::cerr << "Failed to save result: " << ret << std::endl;
+            return 1;
+        }
+        std::cout << "Number of detections: " << results.size() << std::endl;
+        std::cout << "Saved result to: " << outputPath << std::endl;
     } else {
-        VisualizeAndSaveClassification(img, results, classes, outputPath);
+        cv::Mat img = cv::imread(inputPath);
+        VisualizeAndSaveClassification(img, results, classes, outputPath, renderParams.showWindow);
     }
 
     return 0;
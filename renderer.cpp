@@ -0,0 +1,289 @@
+#include "renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+namespace
+{
+    const int LABEL_FONT            = cv::FONT_HERSHEY_SIMPLEX;
+    const int CONFIDENCE_STEPS      = 101;
+
+    int ToPercent(float confidence)
+    {
+        return std::clamp(int(confidence * 100), 0, CONFIDENCE_STEPS - 1);
+    }
+
+    bool IsImagePath(const std::string& path)
+    {
+        std::vector<std::string> imageExtensions    = {".jpg", ".jpeg", ".png", ".bmp", ".tiff"};
+        std::string extension                       = std::filesystem::path(path).extension().string();
+        return std::find(imageExtensions.begin(), imageExtensions.end(), extension) != imageExtensions.end();
+    }
+}
+
+YOLO8Renderer::YOLO8Renderer()
+{}
+
+YOLO8Renderer::~YOLO8Renderer()
+{}
+
+
+char* YOLO8Renderer::CreateRenderer(const std::vector<std::string>& iClasses, DL_RENDER_PARAM& iParams)
+{
+    classes                 = iClasses;
+    params                  = iParams;
+
+    // Golden-ratio hue steps keep neighbouring class ids visually distinct.
+    int colorNum            = std::max(int(classes.size()), 1);
+    cv::Mat hsv(1, colorNum, CV_8UC3);
+    for (int i = 0; i < colorNum; i++)
+    {
+        double hue          = std::fmod(i * 0.618033988749895, 1.0) * 180.0;
+        hsv.at<cv::Vec3b>(0, i) = cv::Vec3b(uchar(hue), 200, 255);
+    }
+    cv::Mat bgr;
+    cv::cvtColor(hsv, bgr, cv::COLOR_HSV2BGR);
+
+    palette.clear();
+    for (int i = 0; i < colorNum; i++)
+    {
+        cv::Vec3b color     = bgr.at<cv::Vec3b>(0, i);
+        palette.push_back(cv::Scalar(color[0], color[1], color[2]));
+    }
+
+    labelSizes.assign(classes.size() * CONFIDENCE_STEPS, cv::Size());
+
+    return RET_OK;
+}
+
+
+const DL_RENDER_PARAM& YOLO8Renderer::Params() const
+{
+    return params;
+}
+
+
+cv::Size YOLO8Renderer::LabelSize(int classId, int percent, const std::string& label)
+{
+    int baseline            = 0;
+    if (classId < 0 || classId >= int(classes.size()))
+    {
+        return cv::getTextSize(label, LABEL_FONT, params.fontScale, 1, &baseline);
+    }
+
+    cv::Size& size          = labelSizes[classId * CONFIDENCE_STEPS + percent];
+    if (size.width == 0)
+    {
+        size                = cv::getTextSize(label, LABEL_FONT, params.fontScale, 1, &baseline);
+    }
+    return size;
+}
+
+
+char* YOLO8Renderer::Render(cv::Mat& ioImg, const std::vector<DL_RESULT>& iResults)
+{
+    if (ioImg.type() != CV_8UC3)
+    {
+        return "[YOLO_V8]: Renderer expects a BGR frame.";
+    }
+    if (palette.empty())
+    {
+        return "[YOLO_V8]: Renderer is not created.";
+    }
+
+    for (const DL_RESULT& result : iResults)
+    {
+        if (result.box.area() <= 0)
+        {
+            continue;
+        }
+
+        int percent         = ToPercent(result.confidence);
+        bool known          = result.classId >= 0 && result.classId < int(classes.size());
+        std::string name    = known ? classes[result.classId] : std::to_string(result.classId);
+        std::string label   = name + " " + std::to_string(percent) + "%";
+        cv::Scalar color    = known ? palette[result.classId] : palette.back();
+        cv::Size labelSize  = LabelSize(result.classId, percent, label);
+
+        cv::rectangle(ioImg, result.box, color, params.thickness);
+        cv::rectangle(ioImg,
+                      cv::Point(result.box.x, result.box.y - labelSize.height - 5),
+                      cv::Point(result.box.x + labelSize.width, result.box.y),
+                      color, cv::FILLED);
+        cv::putText(ioImg, label, cv::Point(result.box.x, result.box.y - 5), LABEL_FONT, params.fontScale, cv::Scalar(0, 0, 0), 1);
+
+        if (params.verbose)
+        {
+            std::cout << "[YOLO_V8]: " << label << " [" << result.box.x << ", " << result.box.y
+                      << ", " << result.box.width << ", " << result.box.height << "]" << std::endl;
+        }
+    }
+
+    return RET_OK;
+}
+
+
+YOLO8AsyncWriter::YOLO8AsyncWriter()
+    : closing(false), sourceFps(0.0), error(RET_OK), isVideo(false), frameIndex(0)
+{}
+
+YOLO8AsyncWriter::~YOLO8AsyncWriter()
+{
+    Close();
+}
+
+
+char* YOLO8AsyncWriter::Open(const std::string& outputPath, DL_RENDER_PARAM& iParams)
+{
+    if (worker.joinable())
+    {
+        return "[YOLO_V8]: Writer is already open.";
+    }
+    if (iParams.videoFourcc.size() != 4)
+    {
+        return "[YOLO_V8]: Video fourcc must have 4 characters.";
+    }
+
+    std::filesystem::path outputDir = std::filesystem::path(outputPath).parent_path();
+    if (!outputDir.empty() && !std::filesystem::exists(outputDir))
+    {
+        std::filesystem::create_directories(outputDir);
+    }
+
+    path                    = outputPath;
+    params                  = iParams;
+    params.maxQueue         = std::max(params.maxQueue, size_t(1));
+    isVideo                 = !IsImagePath(outputPath);
+    encodeParams            = { cv::IMWRITE_JPEG_QUALITY, std::clamp(params.jpegQuality, 0, 100) };
+    frameIndex              = 0;
+    closing                 = false;
+    sourceFps               = 0.0;
+    error                   = RET_OK;
+    queue.clear();
+
+    worker                  = std::thread(&YOLO8AsyncWriter::WriterLoop, this);
+
+    return RET_OK;
+}
+
+
+char* YOLO8AsyncWriter::Submit(const cv::Mat& iImg, double fps)
+{
+    char* ret               = error.load();
+    if (ret != RET_OK)
+    {
+        return ret;
+    }
+
+    cv::Mat frame           = iImg.clone();
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        notFull.wait(lock, [this] { return queue.size() < params.maxQueue || closing; });
+        if (closing || !worker.joinable())
+        {
+            return "[YOLO_V8]: Writer is not open.";
+        }
+        if (fps > 0.0 && sourceFps <= 0.0)
+        {
+            sourceFps       = fps;
+        }
+        queue.push_back(std::move(frame));
+    }
+    notEmpty.notify_one();
+
+    return RET_OK;
+}
+
+
+char* YOLO8AsyncWriter::Close()
+{
+    if (!worker.joinable())
+    {
+        return error.load();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        closing             = true;
+    }
+    notEmpty.notify_all();
+    notFull.notify_all();
+    worker.join();
+
+    return error.load();
+}
+
+
+void YOLO8AsyncWriter::WriterLoop()
+{
+    while (true)
+    {
+        cv::Mat frame;
+        double fps;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            notEmpty.wait(lock, [this] { return !queue.empty() || closing; });
+            if (queue.empty())
+            {
+                break;
+            }
+            frame           = std::move(queue.front());
+            queue.pop_front();
+            fps             = sourceFps > 0.0 ? sourceFps : params.videoFps;
+        }
+        notFull.notify_one();
+
+        // After a failure keep draining so producers never block on a full queue.
+        if (error.load() == RET_OK)
+        {
+            char* ret       = Encode(frame, fps);
+            if (ret != RET_OK)
+            {
+                error       = ret;
+            }
+        }
+    }
+
+    if (video.isOpened())
+    {
+        video.release();
+    }
+}
+
+
+char* YOLO8AsyncWriter::Encode(const cv::Mat& iImg, double fps)
+{
+    if (isVideo)
+    {
+        if (!video.isOpened())
+        {
+            const std::string& c    = params.videoFourcc;
+            int fourcc      = cv::VideoWriter::fourcc(c[0], c[1], c[2], c[3]);
+            if (!video.open(path, fourcc, fps, iImg.size()))
+            {
+                return "[YOLO_V8]: Unable to open video writer.";
+            }
+        }
+        video.write(iImg);
+    }
+    else
+    {
+        // Further frames of an image output get a numeric suffix.
+        std::string framePath   = path;
+        if (frameIndex > 0)
+        {
+            std::filesystem::path p(path);
+            char suffix[16];
+            std::snprintf(suffix, sizeof(suffix), "_%06d", frameIndex);
+            framePath       = (p.parent_path() / (p.stem().string() + suffix + p.extension().string())).string();
+        }
+        if (!cv::imwrite(framePath, iImg, encodeParams))
+        {
+            return "[YOLO_V8]: Failed to write annotated image.";
+        }
+    }
+
+    frameIndex++;
+    return RET_OK;
+}
@@ -0,0 +1,111 @@
+#include "runtime.h"
+#include <iostream>
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+YOLO8Runtime::YOLO8Runtime()
+    : sharedCpuArena(false)
+{}
+
+YOLO8Runtime::~YOLO8Runtime()
+{}
+
+
+char* YOLO8Runtime::CreateRuntime(DL_RUNTIME_PARAM& iParams)
+{
+    try {
+        Ort::ThreadingOptions threadingOptions;
+        threadingOptions.SetGlobalIntraOpNumThreads(iParams.intraOpNumThreads);
+        threadingOptions.SetGlobalInterOpNumThreads(iParams.interOpNumThreads);
+        threadingOptions.SetGlobalSpinControl(iParams.allowSpinning ? 1 : 0);
+        if (!iParams.intraOpThreadAffinity.empty())
+        {
+            Ort::ThrowOnError(Ort::GetApi().SetGlobalIntraOpThreadAffinity(threadingOptions,
+                iParams.intraOpThreadAffinity.c_str()));
+        }
+
+        env                         = Ort::Env(threadingOptions, OrtLoggingLevel(iParams.logSeverityLevel), "Yolo");
+
+        sharedCpuArena              = iParams.sharedCpuArena;
+        if (sharedCpuArena)
+        {
+            // Defaults for every field; sessions opt in through session.use_env_allocators.
+            Ort::ArenaCfg arenaCfg(0, -1, -1, -1);
+            Ort::MemoryInfo memoryInfo  = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+            env.CreateAndRegisterAllocator(memoryInfo, arenaCfg);
+        }
+
+        return RET_OK;
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "[YOLO_V8]:" << e.what() << std::endl;
+        return "[YOLO_V8]: Create runtime failed.";
+    }
+}
+
+
+void YOLO8Runtime::ApplySessionOptions(Ort::SessionOptions& sessionOptions) const
+{
+    sessionOptions.DisablePerSessionThreads();
+    if (sharedCpuArena)
+    {
+        sessionOptions.AddConfigEntry("session.use_env_allocators", "1");
+    }
+}
+
+
+Ort::Env& YOLO8Runtime::GetEnv()
+{
+    return env;
+}
+
+
+char* YOLO8Runtime::QueryStats(DL_RUNTIME_STATS& oStats)
+{
+    oStats                          = DL_RUNTIME_STATS();
+
+#ifdef _WIN32
+    return "[YOLO_V8]: Runtime stats are not supported on Windows.";
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return "[YOLO_V8]: getrusage failed.";
+    }
+#ifdef __APPLE__
+    oStats.peakResidentKb           = usage.ru_maxrss / 1024;
+#else
+    oStats.peakResidentKb           = usage.ru_maxrss;
+#endif
+    oStats.voluntaryCtxSwitches     = usage.ru_nvcsw;
+    oStats.involuntaryCtxSwitches   = usage.ru_nivcsw;
+
+    // Current RSS is only exposed through procfs; fall back to the peak elsewhere.
+    oStats.residentKb               = oStats.peakResidentKb;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.rfind("VmRSS:", 0) == 0)
+        {
+            oStats.residentKb       = std::stol(line.substr(6));
+            break;
+        }
+    }
+
+    return RET_OK;
+#endif
+}
+
+
+void YOLO8Runtime::PrintStats(const char* tag, const DL_RUNTIME_STATS& iStats)
+{
+    std::cout << "[YOLO_V8]: " << tag << ": " << iStats.residentKb << " kB RSS, "
+              << iStats.peakResidentKb << " kB peak RSS, "
+              << iStats.voluntaryCtxSwitches << " voluntary / "
+              << iStats.involuntaryCtxSwitches << " involuntary context switches." << std::endl;
+}
@@ -0,0 +1,577 @@
+// Appends a decode + NMS subgraph to a YOLOv8 detection model so that it can be
+// loaded as YOLO_DETECT_E2E. The new last graph output "detections" is
+// [1, num_dets, 6] with (x1, y1, x2, y2, score, class) per row, in the
+// letterboxed input coordinates.
+//
+// The model is extended at the protobuf wire level: a second ModelProto.graph
+// field holding only the new nodes, initializers and output is appended to the
+// file, and protobuf parsers merge it into the existing graph. This keeps the
+// tool free of ONNX/protobuf dependencies. The raw head stays a graph output.
+//
+// Only fp32 and fp16 heads are accepted. ONNX NonMaxSuppression is fp32-only,
+// so an fp16 head is cast to fp32 for the subgraph and the detections are cast
+// back to fp16, matching YOLO_DETECT_E2E_HALF.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// ONNX protobuf field numbers and enums used below.
+enum
+{
+    MODEL_GRAPH             = 7,
+    MODEL_OPSET_IMPORT      = 8,
+
+    OPSET_DOMAIN            = 1,
+    OPSET_VERSION           = 2,
+
+    GRAPH_NODE              = 1,
+    GRAPH_INITIALIZER       = 5,
+    GRAPH_OUTPUT            = 12,
+
+    NODE_INPUT              = 1,
+    NODE_OUTPUT             = 2,
+    NODE_NAME               = 3,
+    NODE_OP_TYPE            = 4,
+    NODE_ATTRIBUTE          = 5,
+
+    ATTR_NAME               = 1,
+    ATTR_I                  = 3,
+    ATTR_INTS               = 8,
+    ATTR_TYPE               = 20,
+    ATTR_TYPE_INT           = 2,
+    ATTR_TYPE_INTS          = 7,
+
+    TENSOR_DIMS             = 1,
+    TENSOR_DATA_TYPE        = 2,
+    TENSOR_NAME             = 8,
+    TENSOR_RAW_DATA         = 9,
+    TENSOR_FLOAT            = 1,
+    TENSOR_INT64            = 7,
+    TENSOR_FLOAT16          = 10,
+
+    VALUE_INFO_NAME         = 1,
+    VALUE_INFO_TYPE         = 2,
+    TYPE_TENSOR_TYPE        = 1,
+    TENSOR_TYPE_ELEM_TYPE   = 1,
+    TENSOR_TYPE_SHAPE       = 2,
+    SHAPE_DIM               = 1,
+    DIM_VALUE               = 1,
+    DIM_PARAM               = 2,
+
+    WIRE_VARINT             = 0,
+    WIRE_FIXED64            = 1,
+    WIRE_BYTES              = 2,
+    WIRE_FIXED32            = 5
+};
+
+
+class ProtoWriter
+{
+    public:
+        void Varint(int field, uint64_t value)
+        {
+            Key(field, WIRE_VARINT);
+            Raw(value);
+        }
+
+        void Bytes(int field, const std::string& value)
+        {
+            Key(field, WIRE_BYTES);
+            Raw(value.size());
+            buffer += value;
+        }
+
+        void Message(int field, const ProtoWriter& message)
+        {
+            Bytes(field, message.buffer);
+        }
+
+        const std::string& Data() const
+        {
+            return buffer;
+        }
+
+    private:
+        void Key(int field, int wireType)
+        {
+            Raw((uint64_t(field) << 3) | uint64_t(wireType));
+        }
+
+        void Raw(uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                buffer.push_back(char((value & 0x7f) | 0x80));
+                value >>= 7;
+            }
+            buffer.push_back(char(value));
+        }
+
+        std::string buffer;
+};
+
+
+class ProtoReader
+{
+    public:
+        explicit ProtoReader(const std::string& data)
+            : data(data), pos(0)
+        {}
+
+        // Returns false at the end of the message, throws on malformed input.
+        bool Next(int& field, uint64_t& value, std::string& bytes)
+        {
+            if (pos >= data.size())
+            {
+                return false;
+            }
+
+            uint64_t key    = Raw();
+            field           = int(key >> 3);
+            switch (key & 7)
+            {
+                case WIRE_VARINT:
+                    value   = Raw();
+                    break;
+                case WIRE_FIXED64:
+                    Skip(8);
+                    break;
+                case WIRE_BYTES:
+                {
+                    uint64_t size   = Raw();
+                    Check(size);
+                    bytes   = data.substr(pos, size);
+                    pos     += size;
+                    break;
+                }
+                case WIRE_FIXED32:
+                    Skip(4);
+                    break;
+                default:
+                    throw std::runtime_error("unsupported protobuf wire type");
+            }
+            return true;
+        }
+
+    private:
+        uint64_t Raw()
+        {
+            uint64_t value  = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                Check(1);
+                uint8_t byte    = uint8_t(data[pos++]);
+                value           |= uint64_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                {
+                    return value;
+                }
+            }
+            throw std::runtime_error("malformed protobuf varint");
+        }
+
+        void Skip(size_t size)
+        {
+            Check(size);
+            pos += size;
+        }
+
+        void Check(uint64_t size)
+        {
+            if (size > data.size() - pos)
+            {
+                throw std::runtime_error("truncated protobuf message");
+            }
+        }
+
+        const std::string& data;
+        size_t pos;
+};
+
+
+typedef struct _MODEL_INFO
+{
+    int64_t opsetVersion    = 0;
+    std::vector<std::string> outputNames;
+    std::vector<int> outputElemTypes;   // 0 when the output declares no tensor type
+} MODEL_INFO;
+
+
+int ReadElemType(const std::string& valueInfoType)
+{
+    int field;
+    uint64_t value;
+    std::string bytes;
+    ProtoReader typeReader(valueInfoType);
+    while (typeReader.Next(field, value, bytes))
+    {
+        if (field != TYPE_TENSOR_TYPE)
+        {
+            continue;
+        }
+        std::string tensorType  = bytes;
+        ProtoReader tensorTypeReader(tensorType);
+        while (tensorTypeReader.Next(field, value, bytes))
+        {
+            if (field == TENSOR_TYPE_ELEM_TYPE)
+            {
+                return int(value);
+            }
+        }
+    }
+    return 0;
+}
+
+
+MODEL_INFO InspectModel(const std::string& model)
+{
+    MODEL_INFO info;
+    ProtoReader modelReader(model);
+    int field;
+    uint64_t value;
+    std::string bytes;
+
+    while (modelReader.Next(field, value, bytes))
+    {
+        if (field == MODEL_OPSET_IMPORT)
+        {
+            std::string domain;
+            int64_t version     = 0;
+            std::string opset   = bytes;
+            ProtoReader opsetReader(opset);
+            while (opsetReader.Next(field, value, bytes))
+            {
+                if (field == OPSET_DOMAIN)  domain  = bytes;
+                if (field == OPSET_VERSION) version = int64_t(value);
+            }
+            if (domain.empty() || domain == "ai.onnx")
+            {
+                info.opsetVersion   = version;
+            }
+        }
+        else if (field == MODEL_GRAPH)
+        {
+            std::string graph   = bytes;
+            ProtoReader graphReader(graph);
+            while (graphReader.Next(field, value, bytes))
+            {
+                if (field != GRAPH_OUTPUT)
+                {
+                    continue;
+                }
+                std::string valueInfo   = bytes;
+                std::string name;
+                int elemType            = 0;
+                ProtoReader valueInfoReader(valueInfo);
+                while (valueInfoReader.Next(field, value, bytes))
+                {
+                    if (field == VALUE_INFO_NAME) name      = bytes;
+                    if (field == VALUE_INFO_TYPE) elemType  = ReadElemType(bytes);
+                }
+                info.outputNames.push_back(name);
+                info.outputElemTypes.push_back(elemType);
+            }
+        }
+    }
+
+    return info;
+}
+
+
+ProtoWriter IntAttribute(const std::string& name, int64_t value)
+{
+    ProtoWriter attr;
+    attr.Bytes(ATTR_NAME, name);
+    attr.Varint(ATTR_I, uint64_t(value));
+    attr.Varint(ATTR_TYPE, ATTR_TYPE_INT);
+    return attr;
+}
+
+
+ProtoWriter IntsAttribute(const std::string& name, const std::vector<int64_t>& values)
+{
+    ProtoWriter attr;
+    attr.Bytes(ATTR_NAME, name);
+    for (int64_t value : values)
+    {
+        attr.Varint(ATTR_INTS, uint64_t(value));
+    }
+    attr.Varint(ATTR_TYPE, ATTR_TYPE_INTS);
+    return attr;
+}
+
+
+template<typename T>
+ProtoWriter Initializer(const std::string& name, int dataType, const std::vector<int64_t>& dims, const std::vector<T>& values)
+{
+    // raw_data is little-endian, which matches every host ORT ships for.
+    std::string raw(values.size() * sizeof(T), '\0');
+    std::memcpy(&raw[0], values.data(), raw.size());
+
+    ProtoWriter tensor;
+    for (int64_t dim : dims)
+    {
+        tensor.Varint(TENSOR_DIMS, uint64_t(dim));
+    }
+    tensor.Varint(TENSOR_DATA_TYPE, uint64_t(dataType));
+    tensor.Bytes(TENSOR_NAME, name);
+    tensor.Bytes(TENSOR_RAW_DATA, raw);
+    return tensor;
+}
+
+
+class GraphBuilder
+{
+    public:
+        void Node(const std::string& opType, const std::vector<std::string>& inputs, const std::string& output,
+                  const std::vector<ProtoWriter>& attributes = {})
+        {
+            ProtoWriter node;
+            for (const std::string& input : inputs)
+            {
+                node.Bytes(NODE_INPUT, input);
+            }
+            node.Bytes(NODE_OUTPUT, output);
+            node.Bytes(NODE_NAME, output);
+            node.Bytes(NODE_OP_TYPE, opType);
+            for (const ProtoWriter& attr : attributes)
+            {
+                node.Message(NODE_ATTRIBUTE, attr);
+            }
+            graph.Message(GRAPH_NODE, node);
+        }
+
+        void Int64(const std::string& name, const std::vector<int64_t>& dims, const std::vector<int64_t>& values)
+        {
+            graph.Message(GRAPH_INITIALIZER, Initializer(name, TENSOR_INT64, dims, values));
+        }
+
+        void Float(const std::string& name, const std::vector<int64_t>& dims, const std::vector<float>& values)
+        {
+            graph.Message(GRAPH_INITIALIZER, Initializer(name, TENSOR_FLOAT, dims, values));
+        }
+
+        // Output shaped [1, num_dets, 6] of the given element type.
+        void Output(const std::string& name, int elemType)
+        {
+            ProtoWriter batch, dets, row, shape, tensorType, type, valueInfo;
+            batch.Varint(DIM_VALUE, 1);
+            dets.Bytes(DIM_PARAM, "num_dets");
+            row.Varint(DIM_VALUE, 6);
+            shape.Message(SHAPE_DIM, batch);
+            shape.Message(SHAPE_DIM, dets);
+            shape.Message(SHAPE_DIM, row);
+            tensorType.Varint(TENSOR_TYPE_ELEM_TYPE, uint64_t(elemType));
+            tensorType.Message(TENSOR_TYPE_SHAPE, shape);
+            type.Message(TYPE_TENSOR_TYPE, tensorType);
+            valueInfo.Bytes(VALUE_INFO_NAME, name);
+            valueInfo.Message(VALUE_INFO_TYPE, type);
+            graph.Message(GRAPH_OUTPUT, valueInfo);
+        }
+
+        const ProtoWriter& Graph() const
+        {
+            return graph;
+        }
+
+    private:
+        ProtoWriter graph;
+};
+
+
+// head: [1, 4 + nc, anchors] with (cx, cy, w, h, class scores...) per anchor,
+// of elemType TENSOR_FLOAT or TENSOR_FLOAT16. The subgraph itself runs in fp32.
+ProtoWriter BuildSubgraph(const std::string& headName, int elemType, const std::string& output,
+                          int64_t maxDet, float iouThreshold, float scoreThreshold)
+{
+    const std::string p     = "e2e/";
+    const int64_t end       = std::numeric_limits<int64_t>::max();
+    GraphBuilder g;
+
+    g.Int64(p + "zero",      { 1 }, { 0 });
+    g.Int64(p + "two",       { 1 }, { 2 });
+    g.Int64(p + "four",      { 1 }, { 4 });
+    g.Int64(p + "end",       { 1 }, { end });
+    g.Int64(p + "axis1",     { 1 }, { 1 });
+    g.Int64(p + "axis2",     { 1 }, { 2 });
+    g.Int64(p + "box_col",   {},    { 2 });
+    g.Int64(p + "max_det",   { 1 }, { maxDet });
+    g.Float(p + "iou",       { 1 }, { iouThreshold });
+    g.Float(p + "score",     { 1 }, { scoreThreshold });
+    g.Float(p + "half",      { 1 }, { 0.5f });
+
+    bool fp16               = elemType == TENSOR_FLOAT16;
+    std::string head        = headName;
+    if (fp16)
+    {
+        head                = p + "head_fp32";
+        g.Node("Cast", { headName }, head, { IntAttribute("to", TENSOR_FLOAT) });
+    }
+
+    // Best class per anchor, so NMS runs once over anchors instead of once per class.
+    g.Node("Slice", { head, p + "zero", p + "four", p + "axis1" }, p + "boxes_t");
+    g.Node("Transpose", { p + "boxes_t" }, p + "boxes", { IntsAttribute("perm", { 0, 2, 1 }) });
+    g.Node("Slice", { head, p + "four", p + "end", p + "axis1" }, p + "scores");
+    g.Node("ArgMax", { p + "scores" }, p + "class_idx", { IntAttribute("axis", 1), IntAttribute("keepdims", 1) });
+    g.Node("GatherElements", { p + "scores", p + "class_idx" }, p + "best_score", { IntAttribute("axis", 1) });
+
+    g.Node("NonMaxSuppression", { p + "boxes", p + "best_score", p + "max_det", p + "iou", p + "score" },
+           p + "selected", { IntAttribute("center_point_box", 1) });
+    g.Node("Gather", { p + "selected", p + "box_col" }, p + "keep", { IntAttribute("axis", 1) });
+
+    // Only the kept rows are converted to corners.
+    g.Node("Gather", { p + "boxes", p + "keep" }, p + "kept_boxes", { IntAttribute("axis", 1) });
+    g.Node("Slice", { p + "kept_boxes", p + "zero", p + "two", p + "axis2" }, p + "kept_cxcy");
+    g.Node("Slice", { p + "kept_boxes", p + "two", p + "four", p + "axis2" }, p + "kept_wh");
+    g.Node("Mul", { p + "kept_wh", p + "half" }, p + "kept_half_wh");
+    g.Node("Sub", { p + "kept_cxcy", p + "kept_half_wh" }, p + "kept_x1y1");
+    g.Node("Add", { p + "kept_cxcy", p + "kept_half_wh" }, p + "kept_x2y2");
+
+    g.Node("Gather", { p + "best_score", p + "keep" }, p + "kept_score_t", { IntAttribute("axis", 2) });
+    g.Node("Transpose", { p + "kept_score_t" }, p + "kept_score", { IntsAttribute("perm", { 0, 2, 1 }) });
+    g.Node("Gather", { p + "class_idx", p + "keep" }, p + "kept_class_i", { IntAttribute("axis", 2) });
+    g.Node("Cast", { p + "kept_class_i" }, p + "kept_class_t", { IntAttribute("to", TENSOR_FLOAT) });
+    g.Node("Transpose", { p + "kept_class_t" }, p + "kept_class", { IntsAttribute("perm", { 0, 2, 1 }) });
+
+    std::string rows        = fp16 ? p + "detections_fp32" : output;
+    g.Node("Concat", { p + "kept_x1y1", p + "kept_x2y2", p + "kept_score", p + "kept_class" }, rows,
+           { IntAttribute("axis", 2) });
+    if (fp16)
+    {
+        g.Node("Cast", { rows }, output, { IntAttribute("to", TENSOR_FLOAT16) });
+    }
+    g.Output(output, elemType);
+
+    return g.Graph();
+}
+
+
+void PrintUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " <input.onnx> <output.onnx> [max_det=300] [iou=0.45] [score=0.25]" << std::endl;
+}
+
+
+// Parse the whole of value; throws std::invalid_argument otherwise.
+template<typename T>
+T ParseArg(const std::string& value)
+{
+    size_t used             = 0;
+    T result;
+    if constexpr (std::is_integral<T>::value)
+    {
+        result              = T(std::stoll(value, &used));
+    }
+    else
+    {
+        result              = T(std::stof(value, &used));
+    }
+    if (used != value.size())
+    {
+        throw std::invalid_argument(value);
+    }
+    return result;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3 || argc > 6)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::string inputPath   = argv[1];
+    std::string outputPath  = argv[2];
+    int64_t maxDet          = 300;
+    float iouThreshold      = 0.45f;
+    float scoreThreshold    = 0.25f;
+    try {
+        if (argc > 3) maxDet            = ParseArg<int64_t>(argv[3]);
+        if (argc > 4) iouThreshold      = ParseArg<float>(argv[4]);
+        if (argc > 5) scoreThreshold    = ParseArg<float>(argv[5]);
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Invalid numeric argument." << std::endl;
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if (maxDet <= 0 || !(iouThreshold >= 0.0f && iouThreshold <= 1.0f) || !(scoreThreshold >= 0.0f && scoreThreshold <= 1.0f))
+    {
+        std::cerr << "max_det must be positive, iou and score must be within [0, 1]." << std::endl;
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    const std::string detectionsName = "detections";
+
+    std::ifstream input(inputPath, std::ios::binary);
+    if (!input.is_open())
+    {
+        std::cerr << "Failed to open model: " << inputPath << std::endl;
+        return 1;
+    }
+    std::stringstream contents;
+    contents << input.rdbuf();
+    std::string model       = contents.str();
+
+    MODEL_INFO info;
+    try {
+        info                = InspectModel(model);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Failed to parse model: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (info.outputNames.empty())
+    {
+        std::cerr << "Model has no graph outputs." << std::endl;
+        return 1;
+    }
+    if (info.opsetVersion < 11)
+    {
+        std::cerr << "Model opset " << info.opsetVersion << " is too old, opset 11 or newer is required." << std::endl;
+        return 1;
+    }
+    int headType            = info.outputElemTypes.front();
+    if (headType != TENSOR_FLOAT && headType != TENSOR_FLOAT16)
+    {
+        std::cerr << "Output '" << info.outputNames.front() << "' has element type " << headType
+                  << ", only fp32 (1) and fp16 (10) heads are supported." << std::endl;
+        return 1;
+    }
+    for (const std::string& name : info.outputNames)
+    {
+        if (name == detectionsName)
+        {
+            std::cerr << "Model already has a '" << detectionsName << "' output." << std::endl;
+            return 1;
+        }
+    }
+
+    ProtoWriter extension;
+    extension.Message(MODEL_GRAPH, BuildSubgraph(info.outputNames.front(), headType, detectionsName, maxDet, iouThreshold, scoreThreshold));
+
+    std::ofstream output(outputPath, std::ios::binary);
+    output << model << extension.Data();
+    if (!output.good())
+    {
+        std::cerr << "Failed to write model: " << outputPath << std::endl;
+        return 1;
+    }
+
+    std::cout << "Appended decode + NMS to '" << info.outputNames.front() << "', wrote " << outputPath
+              << " (" << (headType == TENSOR_FLOAT16 ? "fp16" : "fp32") << ", max_det " << maxDet << ", iou " << iouThreshold << ", score " << scoreThreshold << ")." << std::endl;
+    return 0;
+}